@@ -0,0 +1,77 @@
+
+// Helper for the benchmark targets.
+//
+//   mkres_bench_tool corpus <dir> <kind> <count>
+//      Creates a synthetic corpus. Kinds: text, random, many-small, one-huge, keys
+//
+//   mkres_bench_tool measure <command> [args...]
+//      Runs a command and reports wall time and peak RSS for it.
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "corpus.hpp"
+
+using namespace std;
+
+namespace {
+
+int measure(char **argv) {
+    const auto start = chrono::steady_clock::now();
+
+    const auto pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+
+    if (pid == 0) {
+        execvp(argv[0], argv);
+        perror("execvp");
+        _exit(127);
+    }
+
+    int status = 0;
+    rusage usage{};
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        perror("wait4");
+        return 1;
+    }
+
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    // ru_maxrss is in KiB on Linux
+    cout << format("{:.2f} s, peak RSS {:.1f} MiB", elapsed.count(),
+                   usage.ru_maxrss / 1024.0) << endl;
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+} // anon ns
+
+int main(int argc, char **argv) {
+    const string_view cmd = argc > 1 ? argv[1] : "";
+
+    try {
+        if (cmd == "corpus" && argc == 5) {
+            mkres::bench::makeCorpus(argv[2], mkres::bench::toCorpusKind(argv[3]), stoul(argv[4]));
+            return 0;
+        }
+
+        if (cmd == "measure" && argc > 2) {
+            return measure(argv + 2);
+        }
+    } catch(const exception& ex) {
+        cerr << "Failed: " << ex.what() << endl;
+        return 1;
+    }
+
+    cerr << "Usage: " << argv[0] << " corpus <dir> <kind> <count> | measure <command> [args...]" << endl;
+    return -1;
+}
@@ -0,0 +1,26 @@
+# Compiles each generated .cpp file in GENERATED_DIR and reports
+# wall time and peak RSS for the compiler.
+#
+# Usage: cmake -DTOOL=mkres_bench_tool -DCXX=c++ -DCXX_FLAGS="..." -DGENERATED_DIR=dir -P compile_cost.cmake
+
+separate_arguments(flags UNIX_COMMAND "${CXX_FLAGS}")
+file(GLOB sources ${GENERATED_DIR}/*.cpp)
+
+foreach(source ${sources})
+    get_filename_component(name ${source} NAME)
+    file(SIZE ${source} size)
+    math(EXPR size_kib "${size} / 1024")
+
+    execute_process(
+        COMMAND ${TOOL} measure ${CXX} -std=c++20 ${flags} -I${GENERATED_DIR} -c ${source} -o ${GENERATED_DIR}/${name}.o
+        OUTPUT_VARIABLE result
+        OUTPUT_STRIP_TRAILING_WHITESPACE
+        RESULT_VARIABLE status
+        )
+
+    if (NOT status EQUAL 0)
+        message(FATAL_ERROR "Failed to compile ${source}")
+    endif()
+
+    message("${name} (${size_kib} KiB): ${result}")
+endforeach()
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <fstream>
+#include <filesystem>
+#include <random>
+#include <format>
+#include <stdexcept>
+
+// Synthetic input data for the benchmarks.
+
+namespace mkres::bench {
+
+enum class CorpusKind {
+    TEXT,       // JavaScript-like text files of 64 KiB
+    RANDOM,     // Incompressible files of 64 KiB
+    MANY_SMALL, // Files of about 200 bytes, like icons and locale fragments
+    ONE_HUGE,   // One text file. `count` is the size in MiB
+    KEYS        // Tiny files. Used to measure lookups with many keys
+};
+
+inline CorpusKind toCorpusKind(std::string_view name) {
+    if (name == "text") return CorpusKind::TEXT;
+    if (name == "random") return CorpusKind::RANDOM;
+    if (name == "many-small") return CorpusKind::MANY_SMALL;
+    if (name == "one-huge") return CorpusKind::ONE_HUGE;
+    if (name == "keys") return CorpusKind::KEYS;
+    throw std::invalid_argument{std::format("Unknown corpus kind: {}", name)};
+}
+
+// Deterministic text that compresses about like minified JavaScript
+inline std::string makeText(size_t bytes, unsigned seed = 1) {
+    static constexpr auto words = std::to_array<std::string_view>({
+        "function", "return", "const", "let", "this", "props", "state", "=>", "{", "}",
+        "(", ")", ";", "if", "else", "null", "undefined", "document", "window", "value",
+        "length", "push", "map", "filter", "reduce", "Object", "keys", "0", "1", "\"div\"",
+        "className", "children", "useState", "useEffect", "async", "await", "new", "Promise"});
+
+    std::mt19937 rng{seed};
+    std::uniform_int_distribution<size_t> pick{0, words.size() - 1};
+
+    std::string text;
+    text.reserve(bytes + 16);
+    while(text.size() < bytes) {
+        text += words[pick(rng)];
+        text += (pick(rng) % 11 == 0) ? '\n' : ' ';
+    }
+    text.resize(bytes);
+    return text;
+}
+
+inline std::string makeRandom(size_t bytes, unsigned seed = 1) {
+    std::mt19937 rng{seed};
+    std::uniform_int_distribution<int> dist{0, 0xff};
+
+    std::string data(bytes, '\0');
+    for(auto& ch : data) {
+        ch = static_cast<char>(dist(rng));
+    }
+    return data;
+}
+
+inline void writeFile(const std::filesystem::path& path, std::string_view content) {
+    std::ofstream out{path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc};
+    if (!out) {
+        throw std::runtime_error{std::format(R"(Failed to create "{}")", path.string())};
+    }
+    out.write(content.data(), content.size());
+}
+
+// Creates `count` files of the given kind in `dir`.
+inline void makeCorpus(const std::filesystem::path& dir, CorpusKind kind, size_t count) {
+    std::filesystem::create_directories(dir);
+
+    for(size_t i = 0; i < count; ++i) {
+        const auto seed = static_cast<unsigned>(i + 1);
+        switch(kind) {
+        case CorpusKind::TEXT:
+            writeFile(dir / std::format("bundle_{:06}.js", i), makeText(64 * 1024, seed));
+            break;
+        case CorpusKind::RANDOM:
+            writeFile(dir / std::format("blob_{:06}.bin", i), makeRandom(64 * 1024, seed));
+            break;
+        case CorpusKind::MANY_SMALL:
+            writeFile(dir / std::format("icon_{:06}.svg", i),
+                      std::format(R"(<svg xmlns="http://www.w3.org/2000/svg" viewBox="0 0 24 24">)"
+                                  R"(<path d="M{} {}L{} {}Z"/>{}</svg>)",
+                                  i % 24, (i / 24) % 24, 12, 12, makeText(60, seed)));
+            break;
+        case CorpusKind::ONE_HUGE:
+            writeFile(dir / "huge.js", makeText(count * 1024 * 1024));
+            return;
+        case CorpusKind::KEYS:
+            writeFile(dir / std::format("k{:06}.txt", i), std::format("key {}", i));
+            break;
+        }
+    }
+}
+
+} // namespace mkres::bench
@@ -0,0 +1,199 @@
+
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <filesystem>
+#include <random>
+#include <algorithm>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include "mkres.hpp"
+#include "corpus.hpp"
+
+// Generated by CMake. Includes the headers for the embedded resources.
+#include "bench_resources.hpp"
+
+using namespace std;
+using namespace mkres::bench;
+
+namespace {
+
+filesystem::path tempRoot() {
+    static const auto root = filesystem::temp_directory_path()
+                             / format("mkres_bench_{}", getpid());
+    return root;
+}
+
+// Creates the corpus the first time it's requested
+const filesystem::path& corpus(CorpusKind kind, size_t count) {
+    static map<pair<CorpusKind, size_t>, filesystem::path> corpora;
+
+    const auto key = make_pair(kind, count);
+    if (auto it = corpora.find(key); it != corpora.end()) {
+        return it->second;
+    }
+
+    auto dir = tempRoot() / format("corpus_{}_{}", static_cast<int>(kind), count);
+    makeCorpus(dir, kind, count);
+    return corpora.emplace(key, std::move(dir)).first->second;
+}
+
+string testData(CorpusKind kind, size_t bytes) {
+    return kind == CorpusKind::RANDOM ? makeRandom(bytes) : makeText(bytes);
+}
+
+void BM_Scanner(benchmark::State& state, CorpusKind kind) {
+    const auto count = static_cast<size_t>(state.range(0));
+
+    mkres::Config config;
+    config.recurse = true;
+    config.sources.emplace_back(corpus(kind, count));
+
+    for(auto _ : state) {
+        mkres::Scanner scanner{config};
+        auto inputs = scanner.scan();
+        benchmark::DoNotOptimize(inputs.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+void BM_FormatData(benchmark::State& state) {
+    const auto input = makeText(state.range(0));
+    const auto bytes = as_bytes(span{input});
+    size_t output_bytes = 0;
+
+    for(auto _ : state) {
+        ostringstream out;
+        mkres::format_data(out, bytes);
+        output_bytes += out.view().size();
+    }
+
+    state.SetBytesProcessed(state.iterations() * input.size());
+    state.counters["output"] = benchmark::Counter(static_cast<double>(output_bytes),
+                                                  benchmark::Counter::kIsRate,
+                                                  benchmark::Counter::kIs1024);
+}
+
+void BM_GzCompressor(benchmark::State& state, CorpusKind kind) {
+    const auto input = testData(kind, state.range(0));
+    vector<char> compressed;
+    compressed.reserve(input.size() + 1024);
+
+    for(auto _ : state) {
+        compressed.clear();
+        auto range = jgaa::ranges::zlib::gz_compressor<span<const char>>{span{input}};
+        ranges::copy(range, back_inserter(compressed));
+        benchmark::DoNotOptimize(compressed.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * input.size());
+    state.counters["ratio"] = static_cast<double>(input.size()) / compressed.size();
+}
+
+void BM_Generate(benchmark::State& state, CorpusKind kind, string compression, size_t solid) {
+    const auto count = static_cast<size_t>(state.range(0));
+
+    mkres::Config config;
+    config.recurse = true;
+    config.compression = std::move(compression);
+    config.solid_group_size = solid;
+    config.destination = tempRoot() / "generated";
+    config.sources.emplace_back(corpus(kind, count));
+
+    mkres::Scanner scanner{config};
+    const auto inputs = scanner.scan();
+
+    uint64_t bytes = 0;
+    for(const auto& [path, _] : inputs) {
+        bytes += filesystem::file_size(path);
+    }
+
+    for(auto _ : state) {
+        mkres::generate(config, inputs);
+    }
+
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+// Lookup latency in a generated resource class with `count` keys
+template <typename T>
+void BM_Get(benchmark::State& state, string_view name, size_t count) {
+    vector<string> keys;
+    keys.reserve(count);
+    for(size_t i = 0; i < count; ++i) {
+        keys.emplace_back(format("{}/k{:06}.txt", name, i));
+    }
+    ranges::shuffle(keys, mt19937{42});
+
+    size_t i = 0;
+    for(auto _ : state) {
+        const auto& data = T::get(keys[i]);
+        benchmark::DoNotOptimize(&data);
+        if (++i == keys.size()) {
+            i = 0;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename T>
+void BM_ToString(benchmark::State& state, string_view name) {
+    const auto key = format("{}/bundle_000000.js", name);
+    const auto& data = T::get(key);
+    if (data.empty()) {
+        state.SkipWithError("Missing key");
+        return;
+    }
+
+    for(auto _ : state) {
+        auto str = data.toString();
+        benchmark::DoNotOptimize(str.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * data.origLen);
+}
+
+} // anon ns
+
+BENCHMARK_CAPTURE(BM_Scanner, many_small, CorpusKind::MANY_SMALL)->Arg(100)->Arg(10000);
+BENCHMARK_CAPTURE(BM_Scanner, text, CorpusKind::TEXT)->Arg(100);
+
+BENCHMARK(BM_FormatData)->Arg(64 * 1024)->Arg(4 * 1024 * 1024);
+
+BENCHMARK_CAPTURE(BM_GzCompressor, text, CorpusKind::TEXT)->Arg(64 * 1024)->Arg(4 * 1024 * 1024);
+BENCHMARK_CAPTURE(BM_GzCompressor, random, CorpusKind::RANDOM)->Arg(64 * 1024)->Arg(4 * 1024 * 1024);
+
+BENCHMARK_CAPTURE(BM_Generate, many_small_none, CorpusKind::MANY_SMALL, "none", 0)->Arg(1000);
+BENCHMARK_CAPTURE(BM_Generate, many_small_gzip, CorpusKind::MANY_SMALL, "gzip", 0)->Arg(1000);
+BENCHMARK_CAPTURE(BM_Generate, many_small_solid, CorpusKind::MANY_SMALL, "gzip", 64 * 1024)->Arg(1000);
+BENCHMARK_CAPTURE(BM_Generate, text_gzip, CorpusKind::TEXT, "gzip", 0)->Arg(16);
+BENCHMARK_CAPTURE(BM_Generate, random_gzip, CorpusKind::RANDOM, "gzip", 0)->Arg(16);
+BENCHMARK_CAPTURE(BM_Generate, one_huge_gzip, CorpusKind::ONE_HUGE, "gzip", 0)->Arg(16)
+    ->Unit(benchmark::kMillisecond);
+
+#define MKRES_BENCH_GET(count) \
+    BENCHMARK_CAPTURE(BM_Get<mkres::bench::Keys##count>, keys_##count, "keys_" #count, count);
+MKRES_BENCH_KEY_SETS(MKRES_BENCH_GET)
+
+BENCHMARK_CAPTURE(BM_ToString<mkres::bench::Text>, none, "text");
+BENCHMARK_CAPTURE(BM_ToString<mkres::bench::TextGzip>, gzip, "text_gzip");
+
+int main(int argc, char **argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    std::error_code ec;
+    filesystem::remove_all(tempRoot(), ec);
+    return 0;
+}
@@ -0,0 +1,749 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <algorithm>
+#include <set>
+#include <format>
+#include <regex>
+
+#include "gzipranges.hpp"
+
+#ifdef MKRES_WITH_GZIP
+#   include<zlib.h>
+#endif
+
+namespace mkres {
+
+using namespace std;
+using namespace std::string_literals;
+
+using path_t = filesystem::path;
+
+template <class T, class V>
+concept range_of = std::ranges::range<T> && std::is_same_v<V, std::ranges::range_value_t<T>>;
+
+template <class T, class V>
+concept input_range_of = std::ranges::input_range<T> && std::is_same_v<V, std::ranges::range_value_t<T>>;
+
+struct Config {
+    bool verbose = false;
+    bool recurse = false;
+
+    string res_name = "EmbeddedResource";
+    std::string ns = "mkres";
+    std::string filter;
+    std::string exclude;
+    std::string compression = "none";
+
+    // Files smaller than this are packed together in shared compressed groups.
+    // 0 disables solid compression.
+    size_t solid_group_size = 0;
+    // Number of decompressed groups kept in memory by the generated code.
+    size_t solid_cache_size = 4;
+
+    // Emit runtime metrics (hit counters, decompression counts and latency) in the generated code.
+    bool metrics = false;
+
+    path_t destination = "out";
+    vector<path_t> sources;
+};
+
+// Formats one input stream to a span of bytes;
+
+void format_data(ostream& out, input_range_of<byte> auto& in) {
+
+    string_view seperator;
+    auto col = 0;
+
+    out << "{";
+
+    for(const auto& b : in) {
+        const auto ch = to_integer<uint8_t>(b);
+        out << format("{}b({:0>2x})", seperator, ch);
+        seperator = ",";
+
+        if (++col > 20) {
+            out << endl;
+            col = 0;
+        }
+    }
+
+    out << "}";
+}
+
+// Reads an entire file into memory
+inline vector<char> read_file(const path_t& path) {
+    ifstream data_stream(path, ios_base::in | ios_base::binary);
+    if (!data_stream) {
+        throw runtime_error{format(R"(Failed to open "{}")", path.string())};
+    }
+
+    vector<char> buffer(filesystem::file_size(path));
+    data_stream.read(buffer.data(), buffer.size());
+    return buffer;
+}
+
+void generate(const Config& config,
+              const range_of<pair<filesystem::path /* input path */, string  /* name/key */>> auto& inputs) {
+    const auto ns = config.ns;
+    const auto hdr_name = config.destination.string() + ".h";
+    const auto hdr_name_tmp = hdr_name + "~";
+    const auto impl_name = config.destination.string() + ".cpp";
+    const auto impl_name_tmp = impl_name + "~";
+    const auto res_name = config.res_name;
+    const bool is_compressed = config.compression == "gzip";
+    const auto compressed = is_compressed ? "true" : "false";
+    const bool is_solid = config.solid_group_size > 0;
+    const bool with_metrics = config.metrics;
+
+    if (is_solid && !is_compressed) {
+        throw runtime_error{"Solid groups (--solid) require gzip compression"};
+    }
+
+    ofstream impl(impl_name_tmp);
+    ofstream hdr(hdr_name_tmp);
+    //int count = 0;
+
+    // Generate a simple header file
+
+    string solid_fields;
+    if (is_solid) {
+        solid_fields = R"(
+        // Solid group (1-based) this entry is packed into, or 0.
+        // For entries in a group, `data` is the compressed group, not the entry itself.
+        const size_t group{};
+        // Offset to the entry in the uncompressed group.
+        const size_t offset{};
+)";
+    }
+
+    string metrics_includes;
+    string metrics_fields;
+    string metrics_decl;
+    if (with_metrics) {
+        metrics_includes = R"(#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+)";
+        metrics_fields = R"(
+        // 1-based index of the entry, used for metrics. 0 for the empty entry.
+        const size_t index{};
+)";
+        metrics_decl = R"(
+    // Runtime metrics for one entry. The counters are updated with relaxed atomics.
+    struct Stat {
+        std::string_view key;
+        uint64_t hits{};           // Successful lookups with get()
+        uint64_t decompressions{}; // Calls to toString() that had to inflate data
+        uint64_t bytesInflated{};
+        // Histogram for toString(). Bucket i counts calls faster than latencyBucketsUs[i],
+        // the last bucket counts the rest.
+        std::array<uint64_t, 5> latency{};
+    };
+
+    static constexpr std::array<uint64_t, 4> latencyBucketsUs{10, 100, 1000, 10000};
+
+    // Calls fn for each entry, in key order. Does not allocate.
+    static void forEachStat(const std::function<void(const Stat&)>& fn);
+
+    // Copy of the current metrics for all entries
+    static std::vector<Stat> snapshot();
+)";
+    }
+
+    hdr << format(R"(
+// Generated by mkres version {}
+// See: https://github.com/jgaa/mkres
+
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <string>
+{}namespace {} {{
+
+class {} {{
+public:
+    struct Data {{
+        const std::span<const std::byte> data;
+        const size_t origLen{{}};
+{}{}
+        bool empty() const noexcept {{
+            return data.empty();
+        }}
+
+        // Gets the entire buffer. Decompresses the data if it's compressed.
+        std::string toString() const;
+    }};
+
+    static const Data& get(std::string_view key) noexcept;
+
+    static constexpr bool isCompressed() noexcept {{
+        return {};
+    }}
+
+    static constexpr std::string_view compression() noexcept {{
+        return "{}";
+    }}
+{}}};
+}} // namespace
+
+)", MKRES_VERSION_STR, metrics_includes, ns, res_name, solid_fields, metrics_fields,
+    compressed, config.compression, metrics_decl);
+
+    // Generate the implemetation file
+
+/// =============================================================
+/// Start of implementation
+
+
+    if (is_compressed) {
+        impl << R"(
+#ifndef ZLIB_CONST
+#   define ZLIB_CONST
+#endif
+#include <zlib.h>
+#include <cassert>
+#include <stdexcept>
+#include <cstdint>
+#include <format>
+
+)";
+    }
+    if (is_solid) {
+        impl << R"(#include <list>
+#include <memory>
+#include <mutex>
+)";
+    }
+    if (with_metrics) {
+        impl << R"(#include <atomic>
+#include <chrono>
+)";
+    }
+    impl << format(R"(
+
+#include <algorithm>
+#include "{}"
+
+namespace {} {{
+
+namespace {{
+)", hdr_name, ns);
+
+if (is_compressed) {
+    impl << R"(
+/*! Uncompress the entire compressed data from one input buffer to one output buffer of sufficcient size
+ *
+ *  Returns a span over the uncompressed data.
+ */
+
+template <typename In, typename Out>
+auto gz_uncompress_all(const In& in, Out& out) {
+
+    z_stream strm{};
+
+    const auto wsize = MAX_WBITS | 16;
+
+    if (inflateInit2(&strm, wsize) != Z_OK) {
+        throw std::runtime_error{"Failed to initialize decompression"};
+    }
+
+    strm.avail_in = in.size();
+    strm.next_in = reinterpret_cast<const Bytef *>(in.data());
+
+    strm.avail_out = out.size();
+    strm.next_out = reinterpret_cast<Bytef *>(out.data());
+
+    const auto result = inflate(&strm, Z_FINISH);
+    if (result != Z_STREAM_END) {
+        throw std::runtime_error{std::format("Failed to decompress. Error {}", result)};
+    }
+
+    return std::span{out.data(), strm.total_out};
+})";
+}
+
+    impl << R"(
+
+// Actual data
+// (In their infinite wisdom, the C++ committee has decided that a container with std::byte cannot
+//  be initialized with an initializer-list of chars or integers - each byte must be individually
+//  constructed.)
+#define b(ch) std::byte{0x ## ch}
+
+)";
+
+/// =============================================================
+/// Data
+///
+
+    using formatter_t = function<void(ostream&, path_t)>;
+
+    formatter_t formatter = [&config](ostream& out, const path_t& path) {
+
+        ifstream data_stream(path, ios_base::in | ios_base::binary);
+        data_stream.unsetf(ios_base::skipws);
+
+        // compress ?
+
+        auto input_range = ranges::istream_view<char>{data_stream}
+                           | ranges::views::transform([](const auto ch) {
+                                 return byte{static_cast<uint8_t>(ch)};
+                             });
+
+        out << " // " << path << endl;
+
+        if (config.compression == "gzip") {
+            auto compressor = jgaa::ranges::zlib::gz_compressor<decltype(input_range)>(input_range);
+            format_data(out, compressor);
+        } else {
+            format_data(out, input_range);
+        }
+    };
+
+    string_view delimiter;
+
+    struct DataItem {
+        string_view key;
+        string var_name;
+        size_t orig_len{};
+        size_t group{}; // 1-based. 0 if the item has it's own data
+        size_t offset{};
+    };
+
+    std::vector<DataItem> data_names;
+
+    // Small files are concatenated in a solid group, and the group is compressed as one unit.
+    // That allows the compressor to utilize the redundancy between the files.
+    std::vector<std::pair<string /* var_name */, size_t /* orig size */>> group_names;
+    vector<char> group_buffer;
+
+    auto flush_group = [&] {
+        if (group_buffer.empty()) {
+            return;
+        }
+
+        const auto& name = group_names.back().first;
+        impl << format(R"(constexpr auto {} = std::to_array<const std::byte>()", name);
+        impl << " // solid group with " << group_buffer.size() << " bytes" << endl;
+        auto bytes = as_bytes(span<const char>{group_buffer});
+        auto compressor = jgaa::ranges::zlib::gz_compressor<decltype(bytes)>(bytes);
+        format_data(impl, compressor);
+        impl << ");" << endl;
+
+        group_names.back().second = group_buffer.size();
+        group_buffer.clear();
+    };
+
+    // First, make one array for each file.
+    // I have not found a simple constexpr construct to put it directly in the data array
+
+    size_t count = 0;
+    for (const auto& [data_path, key] : inputs) {
+
+        const auto len = filesystem::file_size(data_path);
+
+        if (is_solid && len > 0 && len < config.solid_group_size) {
+            if (group_buffer.size() >= config.solid_group_size) {
+                flush_group();
+            }
+
+            if (group_buffer.empty()) {
+                group_names.emplace_back(format("group_{}", group_names.size() + 1), 0);
+            }
+
+            if (config.verbose) {
+                clog << "Packing " << data_path << " into " << group_names.back().first << endl;
+            }
+
+            const auto offset = group_buffer.size();
+            const auto content = read_file(data_path);
+            group_buffer.insert(group_buffer.end(), content.begin(), content.end());
+            data_names.emplace_back(key, group_names.back().first, len, group_names.size(), offset);
+            continue;
+        }
+
+        auto name = format("data_{}", ++count);
+
+        impl << format(R"(constexpr auto {} = std::to_array<const std::byte>()", name);
+        formatter(impl, data_path);
+        impl << ");" << endl;
+
+        data_names.emplace_back(key, name, len);
+    }
+
+    flush_group();
+
+    impl << format(R"(
+
+#undef b
+
+using data_t = std::pair<std::string_view, {}::Data>;
+constexpr auto data = std::to_array<data_t>({{)", res_name);
+
+    delimiter = {};
+    size_t index = 0;
+    // Now, put the data-elements in an array so we can look it up from a key
+    for(const auto& [key, name, len, group, offset] : data_names) {
+        auto fields = format("{}, {}", name, len);
+        if (is_solid) {
+            fields += format(", {}, {}", group, offset);
+        }
+        if (with_metrics) {
+            fields += format(", {}", ++index);
+        }
+        impl << format(R"({}
+    {{"{}", {{{}}}}})", delimiter, key, fields);
+        delimiter = ", ";
+    }
+
+    impl << "});" << endl;
+
+    if (with_metrics) {
+        impl << format(R"(
+struct Counters {{
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> decompressions;
+    std::atomic<uint64_t> bytes_inflated;
+    std::array<std::atomic<uint64_t>, 5> latency;
+}};
+
+// Zero-initialized, as it has static storage duration
+std::array<Counters, {}> counters;
+
+[[maybe_unused]] void count_inflate(size_t index, uint64_t bytes) {{
+    auto& c = counters[index - 1];
+    c.decompressions.fetch_add(1, std::memory_order_relaxed);
+    c.bytes_inflated.fetch_add(bytes, std::memory_order_relaxed);
+}}
+
+// Adds the time from construction to destruction to the latency histogram for an entry
+class LatencyRecorder {{
+public:
+    explicit LatencyRecorder(size_t index)
+        : index_{{index}} {{}}
+
+    ~LatencyRecorder() {{
+        if (!index_) {{
+            return;
+        }}
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+
+        size_t bucket = 0;
+        const auto& limits = {}::latencyBucketsUs;
+        for(; bucket < limits.size() && static_cast<uint64_t>(elapsed) >= limits[bucket]; ++bucket)
+            ;
+
+        counters[index_ - 1].latency[bucket].fetch_add(1, std::memory_order_relaxed);
+    }}
+
+private:
+    const size_t index_;
+    const std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+}};
+)", data_names.size(), res_name);
+    }
+
+    if (is_solid) {
+        impl << R"(
+using group_t = std::pair<std::span<const std::byte> /* compressed */, size_t /* uncompressed size */>;
+constexpr auto groups = std::to_array<group_t>({)";
+
+        delimiter = {};
+        for(const auto& [name, len] : group_names) {
+            impl << format(R"({}
+    {{{}, {}}})", delimiter, name, len);
+            delimiter = ", ";
+        }
+
+        if (group_names.empty()) {
+            // std::to_array() cannot deduce the size of an empty initializer-list
+            impl << "group_t{}";
+        }
+
+        impl << format(R"(}});
+
+constexpr size_t group_cache_size = {};
+
+// Gets a decompressed solid group. The most recently used groups are cached.
+std::shared_ptr<const std::string> get_group(size_t group{}) {{
+    static std::mutex mutex;
+    static std::list<std::pair<size_t, std::shared_ptr<const std::string>>> cache;
+
+    {{
+        std::lock_guard lock{{mutex}};
+        for(auto it = cache.begin(); it != cache.end(); ++it) {{
+            if (it->first == group) {{
+                cache.splice(cache.begin(), cache, it);
+                return it->second;
+            }}
+        }}
+    }}
+
+    // Decompress without holding the lock
+    const auto& [compressed, len] = groups.at(group - 1);
+    auto buffer = std::make_shared<std::string>();
+    buffer->resize(len);
+    std::span<std::byte> out{{reinterpret_cast<std::byte *>(buffer->data()), buffer->size()}};
+    gz_uncompress_all(compressed, out);
+{}
+    std::lock_guard lock{{mutex}};
+    std::erase_if(cache, [group](const auto& v) {{
+        return v.first == group;
+    }});
+    cache.emplace_front(group, buffer);
+    if (cache.size() > group_cache_size) {{
+        cache.pop_back();
+    }}
+    return buffer;
+}} // get_group()
+)", config.solid_cache_size,
+    with_metrics ? ", size_t index" : "",
+    with_metrics ? "    count_inflate(index, len);\n" : "");
+    }
+
+/// =============================================================
+/// Methods
+
+impl << format(R"(
+
+}} // anon namespace
+
+const {}::Data& {}::get(std::string_view key) noexcept {{
+
+    // C++20 dont't have an algorithm to search for a value in a sorted range.
+    const data_t target{{key, {{}}}};
+    const auto range = std::ranges::lower_bound(data, target, [](const auto& left, const auto& right) {{
+        return left.first < right.first;
+    }});
+
+    if (range != data.end() && range->first == key) {{{}
+        return range->second;
+    }}
+
+    static constexpr data_t empty;
+
+    return empty.second;
+}} // get()
+
+
+std::string {}::Data::toString() const {{
+)", res_name, res_name,
+    with_metrics ? "\n        counters[range->second.index - 1].hits.fetch_add(1, std::memory_order_relaxed);" : "",
+    res_name);
+
+    if (with_metrics) {
+        impl << R"(
+    const LatencyRecorder recorder{index};
+)";
+    }
+
+    if (is_solid) {
+        impl << format(R"(
+    if (group) {{
+        return get_group(group{})->substr(offset, origLen);
+    }}
+)", with_metrics ? ", index" : "");
+    }
+
+    if (is_compressed) {
+    impl << format(R"(
+    if (isCompressed()) {{
+        std::string out_buffer;
+        out_buffer.resize(origLen);
+        std::span<std::byte> out{{reinterpret_cast<std::byte *>(out_buffer.data()), out_buffer.size()}};
+        gz_uncompress_all(data, out);{}
+        return out_buffer;
+    }}
+)", with_metrics ? "\n        count_inflate(index, origLen);" : "");
+    }
+    impl << R"(
+    const char *ptr = reinterpret_cast<const char *>(data.data());
+    std::string str{ptr, data.size()};
+    return str;
+}
+)";
+
+    if (with_metrics) {
+        impl << format(R"(
+void {}::forEachStat(const std::function<void(const Stat&)>& fn) {{
+    for(const auto& [key, entry] : data) {{
+        const auto& c = counters[entry.index - 1];
+        Stat stat{{key,
+                  c.hits.load(std::memory_order_relaxed),
+                  c.decompressions.load(std::memory_order_relaxed),
+                  c.bytes_inflated.load(std::memory_order_relaxed)}};
+        for(size_t i = 0; i < stat.latency.size(); ++i) {{
+            stat.latency[i] = c.latency[i].load(std::memory_order_relaxed);
+        }}
+        fn(stat);
+    }}
+}}
+
+std::vector<{}::Stat> {}::snapshot() {{
+    std::vector<Stat> stats;
+    stats.reserve(data.size());
+    forEachStat([&stats](const Stat& stat) {{
+        stats.push_back(stat);
+    }});
+    return stats;
+}}
+)", res_name, res_name, res_name);
+    }
+
+    impl << R"(} // namespace
+)";
+
+    impl.close();
+    hdr.close();
+
+    std::filesystem::rename(hdr_name_tmp, hdr_name);
+    std::filesystem::rename(impl_name_tmp, impl_name);
+}
+
+class Scanner {
+    using inputs_t = set<path_t>;
+public:
+    using named_inputs_t = map<path_t, vector<path_t>>;
+
+    Scanner(const Config& conf)
+        : conf_{conf} {
+
+        auto apply = [&](auto& cfg, auto & var, const auto& name) {
+            if (!cfg.empty()) {
+                clog << "Applying " << name << ": " << cfg << endl;
+                var.emplace(cfg);
+            }
+        };
+
+        apply(conf_.filter, filter_, "filter");
+        apply(conf_.exclude, exclude_, "negative filter (exclude)");
+    }
+
+    auto scan() {
+        for(const auto& path : conf_.sources) {
+            if (filesystem::is_directory(path)) {
+                if (conf_.recurse) {
+                    scanDir(path.parent_path(), path.filename());
+                } else {
+                    throw runtime_error{format(R"(The path "{}" is a directory! Use "--recurse" option to scan directories.)", path.string())};
+                }
+            } else {
+                add(path.parent_path(), path.filename());
+            }
+        }
+
+        return toRange();
+    }
+
+    auto count() const noexcept {
+        return inputs_.size();
+    }
+
+private:
+    void scanDir(const path_t& root, const path_t& path) {
+        auto scan_path = root;
+        scan_path /= path;
+
+        if (conf_.verbose) {
+            clog << "Scanning directory: " << scan_path << endl;
+        }
+
+        for(const auto& item : filesystem::directory_iterator{scan_path}) {
+            const auto branch = item.path().filename();
+            auto full_path = scan_path;
+            full_path /= branch;
+
+            auto relative_path = path;
+            relative_path /= branch;
+
+            if (filesystem::is_directory(full_path)) {
+                scanDir(root, relative_path);
+                continue;
+            }
+
+            add(root, relative_path);
+        }
+    }
+
+    void add(const path_t& root, const path_t& path) {
+        auto full_path = root;
+        full_path /= path;
+
+        const auto filtered = [&](const regex& filter, const auto& path) {
+            if (regex_match(path.string(), filter)) {
+                return true;
+            }
+            return false;
+        };
+
+        if ((filter_ && !filtered(*filter_, path))
+            || (exclude_ && filtered(*exclude_, path))) {
+            if (conf_.verbose) {
+                clog << "- excluding: " << full_path << " (filter)" << endl;
+            }
+            return;
+        }
+
+        if (filesystem::is_regular_file(full_path)) {
+            if (conf_.verbose) {
+                clog << "Adding : " << full_path  << " as --> " << path << endl;
+            }
+
+            auto [_, added] = inputs_.emplace(full_path);
+            if (added) {
+
+                auto [_, added] = names_.emplace(path);
+                if (!added) {
+                    throw runtime_error{format(R"(The relative name "{}" in path "{}" was already used by another file. Relative paths are used as keys and must be unique!)",
+                                               path.string(), root.string())};
+                }
+
+                named_inputs_[root].emplace_back(path);
+            }
+        } else {
+            if (!filesystem::exists(full_path)) {
+                throw runtime_error{format(R"(File or directory not found: "{}")", path.string())};
+            }
+            cerr << "*** Ignoring non-regular file: " << path << endl;
+        }
+    }
+
+    vector<pair<path_t, string>> toRange() const {
+        vector<pair<path_t, string>> inputs;
+        for(const auto& [root, targets] : named_inputs_) {
+            for(const auto& target : targets) {
+                auto full_path = root;
+                full_path /= target;
+                inputs.emplace_back(full_path, target.string());
+            }
+        }
+
+        ranges::sort(inputs, [](const auto& left, const auto& right) {
+            return left.second < right.second;
+        });
+        return inputs;
+    }
+
+    const Config& conf_;
+    inputs_t inputs_;
+    inputs_t names_;
+    named_inputs_t named_inputs_;
+    optional<regex> filter_;
+    optional<regex> exclude_;
+};
+
+
+} // namespace mkres